@@ -0,0 +1,755 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Benchmark for RLRAudioPropagation using procedurally generated reference scenes.
+//
+// Each run prints one JSON object per line to stdout, so that results can be compared
+// between library versions. If a baseline file from an earlier run is given, every metric
+// is compared with the matching baseline record, and regressions are reported on stderr.
+// Build and usage instructions are in the README.
+
+#include "RLRAudioPropagation.h"
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//******************************************************************************
+// Utilities
+
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince( Clock::time_point start )
+{
+	return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+void Check( RLRA_Error error, const char* what )
+{
+	if ( error != RLRA_Success )
+	{
+		std::fprintf( stderr, "error: %s failed with code %d\n", what, (int)error );
+		std::exit( 1 );
+	}
+}
+
+// Return the peak resident set size of the calling process in bytes.
+// Each benchmark run happens in its own child process, so this is the peak of that run only.
+uint64_t PeakRSSBytes()
+{
+	struct rusage usage;
+	if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0;
+	return (uint64_t)usage.ru_maxrss * 1024; // ru_maxrss is in kilobytes on Linux.
+}
+
+std::vector<std::string> Split( const std::string& list )
+{
+	std::vector<std::string> items;
+	size_t start = 0;
+	while ( start <= list.size() )
+	{
+		size_t end = list.find( ',', start );
+		if ( end == std::string::npos )
+			end = list.size();
+		if ( end > start )
+			items.push_back( list.substr( start, end - start ) );
+		start = end + 1;
+	}
+	return items;
+}
+
+// Return count / seconds, or 0 if the duration was too short to measure, so that the output never contains inf.
+double Rate( double count, double seconds )
+{
+	return seconds > 0.0 ? count / seconds : 0.0;
+}
+
+double Median( std::vector<double> values )
+{
+	std::sort( values.begin(), values.end() );
+	return values[values.size() / 2];
+}
+
+//******************************************************************************
+// Reference Scenes
+
+struct Scene
+{
+	float listener[3];
+	std::vector<float> sources; // Packed 3D positions.
+	size_t triangleCount;
+	// Mesh data that is generated before scene loading is timed.
+	std::vector<float> meshVertices;
+	std::vector<uint32_t> meshIndices;
+};
+
+// Paths of the generated mesh files that are used by the file loading scenes.
+std::string gObjFilePath;
+std::string gPlyFilePath;
+
+void AddBox( RLRA_Context context, Scene& scene, float x0, float y0, float z0, float x1, float y1, float z1 )
+{
+	const size_t objectIndex = RLRA_GetObjectCount( context );
+	Check( RLRA_AddObject( context ), "RLRA_AddObject" );
+	const float boxMin[3] = { x0, y0, z0 };
+	const float boxMax[3] = { x1, y1, z1 };
+	Check( RLRA_SetObjectBox( context, objectIndex, boxMin, boxMax, NULL ), "RLRA_SetObjectBox" );
+	scene.triangleCount += 12;
+}
+
+void SetShoeboxPositions( Scene& scene )
+{
+	scene.listener[0] = 2.f; scene.listener[1] = 1.5f; scene.listener[2] = 2.f;
+	scene.sources = { 6.f, 1.5f, 4.f,  4.f, 1.f, 5.f };
+}
+
+// A single 8 x 3 x 6 meter room.
+void BuildShoebox( RLRA_Context context, Scene& scene )
+{
+	AddBox( context, scene, 0.f, 0.f, 0.f, 8.f, 3.f, 6.f );
+	SetShoeboxPositions( scene );
+}
+
+// A 3 x 3 grid of 5 x 3 x 5 meter rooms, connected by 1 x 2 meter doorways.
+void BuildMultiRoom( RLRA_Context context, Scene& scene )
+{
+	const int roomCount = 3;
+	const float roomSize = 5.f, height = 3.f, wall = 0.2f, door = 1.f, doorHeight = 2.f;
+	const float extent = roomCount * roomSize;
+
+	AddBox( context, scene, 0.f, -wall, 0.f, extent, 0.f, extent ); // Floor
+	AddBox( context, scene, 0.f, height, 0.f, extent, height + wall, extent ); // Ceiling
+	for ( int i = 0; i <= roomCount; i++ )
+	{
+		const float p = i * roomSize;
+		const bool outer = ( i == 0 || i == roomCount );
+		for ( int j = 0; j < roomCount; j++ )
+		{
+			const float a = j * roomSize, b = a + roomSize, mid = a + 0.5f * roomSize;
+			if ( outer )
+			{
+				AddBox( context, scene, p - wall, 0.f, a, p, height, b ); // Wall along z
+				AddBox( context, scene, a, 0.f, p - wall, b, height, p ); // Wall along x
+				continue;
+			}
+			// Interior walls have a doorway in the middle of each room side.
+			AddBox( context, scene, p - wall, 0.f, a, p, height, mid - 0.5f * door );
+			AddBox( context, scene, p - wall, 0.f, mid + 0.5f * door, p, height, b );
+			AddBox( context, scene, p - wall, doorHeight, mid - 0.5f * door, p, height, mid + 0.5f * door );
+			AddBox( context, scene, a, 0.f, p - wall, mid - 0.5f * door, height, p );
+			AddBox( context, scene, mid + 0.5f * door, 0.f, p - wall, b, height, p );
+			AddBox( context, scene, mid - 0.5f * door, doorHeight, p - wall, mid + 0.5f * door, height, p );
+		}
+	}
+	scene.listener[0] = 2.5f; scene.listener[1] = 1.5f; scene.listener[2] = 2.5f;
+	scene.sources = { 12.5f, 1.5f, 12.5f,  7.5f, 1.5f, 2.5f };
+}
+
+// A large ground plane with scattered obstacles and no enclosure.
+void BuildOpenField( RLRA_Context context, Scene& scene )
+{
+	AddBox( context, scene, -100.f, -1.f, -100.f, 100.f, 0.f, 100.f );
+	std::mt19937 random( 1 );
+	std::uniform_real_distribution<float> position( -50.f, 50.f ), size( 1.f, 4.f );
+	for ( int i = 0; i < 64; i++ )
+	{
+		const float x = position( random ), z = position( random ), s = size( random );
+		AddBox( context, scene, x, 0.f, z, x + s, s, z + s );
+	}
+	scene.listener[0] = 0.f; scene.listener[1] = 1.5f; scene.listener[2] = 0.f;
+	scene.sources = { 20.f, 1.5f, 10.f,  -30.f, 1.5f, 40.f };
+}
+
+// Generate a finely tessellated, bumpy 8 x 6 meter floor of about 500k triangles.
+void GenerateFloor( std::vector<float>& vertices, std::vector<uint32_t>& indices )
+{
+	const size_t n = 512;
+	const float sizeX = 8.f, sizeZ = 6.f;
+	vertices.reserve( vertices.size() + ( n + 1 ) * ( n + 1 ) * 3 );
+	for ( size_t i = 0; i <= n; i++ )
+	{
+		for ( size_t j = 0; j <= n; j++ )
+		{
+			const float x = sizeX * i / n, z = sizeZ * j / n;
+			vertices.push_back( x );
+			vertices.push_back( 0.05f + 0.04f * std::sin( 7.f * x ) * std::cos( 5.f * z ) );
+			vertices.push_back( z );
+		}
+	}
+	indices.reserve( indices.size() + n * n * 6 );
+	for ( size_t i = 0; i < n; i++ )
+	{
+		for ( size_t j = 0; j < n; j++ )
+		{
+			const uint32_t v = (uint32_t)( i * ( n + 1 ) + j );
+			const uint32_t face[6] = { v, v + 1, v + (uint32_t)n + 1,  v + 1, v + (uint32_t)n + 2, v + (uint32_t)n + 1 };
+			indices.insert( indices.end(), face, face + 6 );
+		}
+	}
+}
+
+void GenerateHighPoly( Scene& scene )
+{
+	GenerateFloor( scene.meshVertices, scene.meshIndices );
+}
+
+// A shoebox room with a high-poly floor that is uploaded from memory.
+void BuildHighPoly( RLRA_Context context, Scene& scene )
+{
+	BuildShoebox( context, scene );
+
+	const size_t objectIndex = RLRA_GetObjectCount( context );
+	Check( RLRA_AddObject( context ), "RLRA_AddObject" );
+	Check( RLRA_AddMeshVertices( context, scene.meshVertices.data(), scene.meshVertices.size() / 3 ), "RLRA_AddMeshVertices" );
+	Check( RLRA_AddMeshIndices( context, scene.meshIndices.data(), scene.meshIndices.size(), 3, NULL ), "RLRA_AddMeshIndices" );
+	Check( RLRA_FinalizeObjectMesh( context, objectIndex ), "RLRA_FinalizeObjectMesh" );
+	scene.triangleCount += scene.meshIndices.size() / 3;
+}
+
+// Write the shoebox room and high-poly floor as one triangle mesh in OBJ or ASCII PLY format.
+// Return the number of triangles that were written, or 0 if the file could not be written.
+size_t WriteMeshFile( const std::string& path, bool ply )
+{
+	std::vector<float> vertices = {
+		0.f, 0.f, 0.f,  8.f, 0.f, 0.f,  8.f, 0.f, 6.f,  0.f, 0.f, 6.f,
+		0.f, 3.f, 0.f,  8.f, 3.f, 0.f,  8.f, 3.f, 6.f,  0.f, 3.f, 6.f };
+	std::vector<uint32_t> indices = {
+		0, 1, 2,  0, 2, 3,  4, 6, 5,  4, 7, 6,  0, 4, 5,  0, 5, 1,
+		1, 5, 6,  1, 6, 2,  2, 6, 7,  2, 7, 3,  3, 7, 4,  3, 4, 0 };
+	std::vector<float> floorVertices;
+	std::vector<uint32_t> floorIndices;
+	GenerateFloor( floorVertices, floorIndices );
+	const uint32_t indexOffset = (uint32_t)( vertices.size() / 3 );
+	vertices.insert( vertices.end(), floorVertices.begin(), floorVertices.end() );
+	for ( uint32_t index : floorIndices )
+		indices.push_back( index + indexOffset );
+
+	FILE* file = std::fopen( path.c_str(), "w" );
+	if ( !file )
+		return 0;
+	const size_t vertexCount = vertices.size() / 3, triangleCount = indices.size() / 3;
+	if ( ply )
+	{
+		std::fprintf( file, "ply\nformat ascii 1.0\nelement vertex %zu\nproperty float x\nproperty float y\nproperty float z\n"
+			"element face %zu\nproperty list uchar int vertex_indices\nend_header\n", vertexCount, triangleCount );
+	}
+	for ( size_t i = 0; i < vertexCount; i++ )
+		std::fprintf( file, ply ? "%g %g %g\n" : "v %g %g %g\n", vertices[3*i], vertices[3*i+1], vertices[3*i+2] );
+	for ( size_t i = 0; i < triangleCount; i++ )
+	{
+		// OBJ indices are 1-based, PLY indices are 0-based.
+		if ( ply )
+			std::fprintf( file, "3 %u %u %u\n", indices[3*i], indices[3*i+1], indices[3*i+2] );
+		else
+			std::fprintf( file, "f %u %u %u\n", indices[3*i] + 1, indices[3*i+1] + 1, indices[3*i+2] + 1 );
+	}
+	const bool ok = !std::ferror( file );
+	return ( std::fclose( file ) == 0 && ok ) ? triangleCount : 0;
+}
+
+void LoadMeshFile( RLRA_Context context, Scene& scene, const std::string& path, bool ply )
+{
+	const size_t objectIndex = RLRA_GetObjectCount( context );
+	Check( RLRA_AddObject( context ), "RLRA_AddObject" );
+	if ( ply )
+		Check( RLRA_SetObjectMeshPLY( context, objectIndex, path.c_str(), NULL ), "RLRA_SetObjectMeshPLY" );
+	else
+		Check( RLRA_SetObjectMeshOBJ( context, objectIndex, path.c_str(), NULL ), "RLRA_SetObjectMeshOBJ" );
+	SetShoeboxPositions( scene );
+}
+
+// The high-poly scene, loaded from a generated OBJ file.
+void BuildObjFile( RLRA_Context context, Scene& scene )
+{
+	LoadMeshFile( context, scene, gObjFilePath, false );
+}
+
+// The high-poly scene, loaded from a generated ASCII PLY file.
+void BuildPlyFile( RLRA_Context context, Scene& scene )
+{
+	LoadMeshFile( context, scene, gPlyFilePath, true );
+}
+
+struct SceneType
+{
+	const char* name;
+	// Generates the mesh data of the scene before loading is timed, or NULL if there is none.
+	void (*generate)( Scene& scene );
+	void (*build)( RLRA_Context context, Scene& scene );
+	// The file that the scene loads from, or NULL if it is built in memory.
+	std::string* meshFilePath;
+	bool ply;
+	size_t meshFileTriangleCount;
+};
+
+SceneType kSceneTypes[] =
+{
+	{ "shoebox", NULL, BuildShoebox, NULL, false, 0 },
+	{ "multiroom", NULL, BuildMultiRoom, NULL, false, 0 },
+	{ "openfield", NULL, BuildOpenField, NULL, false, 0 },
+	{ "highpoly", GenerateHighPoly, BuildHighPoly, NULL, false, 0 },
+	{ "objfile", NULL, BuildObjFile, &gObjFilePath, false, 0 },
+	{ "plyfile", NULL, BuildPlyFile, &gPlyFilePath, true, 0 },
+};
+
+//******************************************************************************
+// Configurations
+
+const char* const kConfigNames[] = { "default", "fast" };
+
+void ApplyConfig( const std::string& name, RLRA_ContextConfiguration& config )
+{
+	if ( name == "fast" )
+	{
+		config.indirectRayCount = 1000;
+		config.indirectRayDepth = 50;
+		config.diffraction = false;
+		config.maxIRLength = 1.f;
+	}
+}
+
+//******************************************************************************
+// Benchmark
+
+struct Options
+{
+	std::vector<std::string> scenes;
+	std::vector<std::string> configs;
+	std::vector<size_t> threadCounts;
+	size_t iterations = 5;
+	size_t queryRayCount = 100000;
+	std::string materialsPath;
+	std::string baselinePath;
+	double tolerance = 0.1;
+};
+
+std::vector<RLRA_Ray> GenerateRays( const Scene& scene, size_t rayCount )
+{
+	std::mt19937 random( 2 );
+	std::normal_distribution<float> normal;
+	std::vector<RLRA_Ray> rays( rayCount );
+	for ( RLRA_Ray& ray : rays )
+	{
+		std::memcpy( ray.origin, scene.listener, sizeof( ray.origin ) );
+		for ( float& d : ray.direction )
+			d = normal( random );
+		ray.tMin = 0.f;
+		ray.tMax = 1000.f;
+	}
+	return rays;
+}
+
+// Trace the rays one at a time, and return the number of rays per second.
+double TraceRays( RLRA_Context context, std::vector<RLRA_Ray> rays, bool firstHit )
+{
+	const Clock::time_point start = Clock::now();
+	for ( RLRA_Ray& ray : rays )
+	{
+		if ( firstHit )
+			Check( RLRA_TraceRayFirstHit( context, &ray ), "RLRA_TraceRayFirstHit" );
+		else
+			Check( RLRA_TraceRayAnyHit( context, &ray ), "RLRA_TraceRayAnyHit" );
+	}
+	return Rate( (double)rays.size(), SecondsSince( start ) );
+}
+
+void RunBenchmark( const Options& options, const SceneType& sceneType, const std::string& configName, size_t threadCount )
+{
+	RLRA_ContextConfiguration config;
+	config.thisSize = sizeof( RLRA_ContextConfiguration );
+	Check( RLRA_ContextConfigurationDefault( &config ), "RLRA_ContextConfigurationDefault" );
+	ApplyConfig( configName, config );
+	config.threadCount = threadCount;
+
+	RLRA_Context context = NULL;
+	Check( RLRA_CreateContext( &context, &config ), "RLRA_CreateContext" );
+	if ( !options.materialsPath.empty() )
+		Check( RLRA_SetMaterialDatabaseJSON( context, options.materialsPath.c_str() ), "RLRA_SetMaterialDatabaseJSON" );
+
+	// Loading covers object creation, mesh upload and mesh file parsing, but not the generation of the mesh data.
+	Scene scene = {};
+	if ( sceneType.generate )
+		sceneType.generate( scene );
+	Clock::time_point start = Clock::now();
+	sceneType.build( context, scene );
+	const double loadSeconds = SecondsSince( start );
+	if ( sceneType.meshFilePath )
+		scene.triangleCount = sceneType.meshFileTriangleCount;
+
+	const RLRA_ChannelLayout layout = { 4, RLRA_ChannelLayoutType_Ambisonics };
+	Check( RLRA_AddListener( context, &layout ), "RLRA_AddListener" );
+	Check( RLRA_SetListenerPosition( context, 0, scene.listener ), "RLRA_SetListenerPosition" );
+	for ( size_t i = 0; i < scene.sources.size() / 3; i++ )
+	{
+		Check( RLRA_AddSource( context ), "RLRA_AddSource" );
+		Check( RLRA_SetSourcePosition( context, i, &scene.sources[3*i] ), "RLRA_SetSourcePosition" );
+	}
+
+	// The first simulation also builds the ray tracing data structures,
+	// so it is reported separately and not included in the median.
+	start = Clock::now();
+	Check( RLRA_Simulate( context ), "RLRA_Simulate" );
+	const double firstSimulateSeconds = SecondsSince( start );
+
+	std::vector<double> simulateSeconds;
+	for ( size_t i = 0; i < options.iterations; i++ )
+	{
+		start = Clock::now();
+		Check( RLRA_Simulate( context ), "RLRA_Simulate" );
+		simulateSeconds.push_back( SecondsSince( start ) );
+	}
+	const double medianSeconds = Median( simulateSeconds );
+	const size_t irCount = RLRA_GetIRCount( context );
+
+	const std::vector<RLRA_Ray> rays = GenerateRays( scene, options.queryRayCount );
+	const double anyHitRaysPerSecond = TraceRays( context, rays, false );
+	const double firstHitRaysPerSecond = TraceRays( context, rays, true );
+
+	Check( RLRA_DestroyContext( context ), "RLRA_DestroyContext" );
+
+	// The record is printed with a single call after all library calls have succeeded,
+	// so a failing run never leaves a partial line in the output.
+	char record[1024];
+	std::snprintf( record, sizeof( record ),
+		"{\"scene\":\"%s\",\"config\":\"%s\",\"threads\":%zu,\"triangles\":%zu,\"irs\":%zu,"
+		"\"loadSeconds\":%.6f,\"firstSimulateSeconds\":%.6f,\"simulateSeconds\":%.6f,\"irsPerSecond\":%.3f,"
+		"\"anyHitRaysPerSecond\":%.1f,\"firstHitRaysPerSecond\":%.1f,\"peakRSSBytes\":%llu}\n",
+		sceneType.name, configName.c_str(), threadCount, scene.triangleCount, irCount,
+		loadSeconds, firstSimulateSeconds, medianSeconds, Rate( (double)irCount, medianSeconds ),
+		anyHitRaysPerSecond, firstHitRaysPerSecond, (unsigned long long)PeakRSSBytes() );
+	std::fputs( record, stdout );
+	std::fflush( stdout );
+}
+
+// Run a benchmark in a child process, so that its peak memory usage is not affected by earlier runs.
+// The child's output is collected through a pipe, and the record is only returned if the run succeeded.
+bool RunBenchmarkInChild( const Options& options, const SceneType& sceneType, const std::string& configName, size_t threadCount,
+	std::string& record )
+{
+	std::fflush( stdout );
+	int fds[2];
+	if ( pipe( fds ) != 0 )
+	{
+		std::perror( "error: pipe" );
+		return false;
+	}
+	const pid_t pid = fork();
+	if ( pid < 0 )
+	{
+		std::perror( "error: fork" );
+		close( fds[0] );
+		close( fds[1] );
+		return false;
+	}
+	if ( pid == 0 )
+	{
+		close( fds[0] );
+		if ( dup2( fds[1], STDOUT_FILENO ) < 0 )
+			std::exit( 1 );
+		close( fds[1] );
+		RunBenchmark( options, sceneType, configName, threadCount );
+		std::exit( 0 );
+	}
+	close( fds[1] );
+	record.clear();
+	char buffer[1024];
+	ssize_t size;
+	while ( ( size = read( fds[0], buffer, sizeof( buffer ) ) ) > 0 )
+		record.append( buffer, (size_t)size );
+	close( fds[0] );
+
+	int status = 0;
+	if ( waitpid( pid, &status, 0 ) != pid || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ||
+		record.empty() || record[record.size() - 1] != '\n' )
+	{
+		std::fprintf( stderr, "error: benchmark run failed (scene %s, config %s, %zu threads)\n",
+			sceneType.name, configName.c_str(), threadCount );
+		return false;
+	}
+	return true;
+}
+
+//******************************************************************************
+// Regression Tracking
+
+struct Metric
+{
+	const char* name;
+	bool higherIsBetter;
+};
+
+const Metric kMetrics[] =
+{
+	{ "loadSeconds", false },
+	{ "firstSimulateSeconds", false },
+	{ "simulateSeconds", false },
+	{ "anyHitRaysPerSecond", true },
+	{ "firstHitRaysPerSecond", true },
+	{ "peakRSSBytes", false },
+};
+
+// Return the value of a field in a result record, without quotes, or an empty string if the record does not have it.
+std::string FindField( const std::string& record, const char* name )
+{
+	const std::string key = std::string( "\"" ) + name + "\":";
+	size_t begin = record.find( key );
+	if ( begin == std::string::npos )
+		return std::string();
+	begin += key.size();
+	if ( begin < record.size() && record[begin] == '"' )
+	{
+		const size_t end = record.find( '"', begin + 1 );
+		return end == std::string::npos ? std::string() : record.substr( begin + 1, end - begin - 1 );
+	}
+	const size_t end = record.find_first_of( ",}", begin );
+	return end == std::string::npos ? std::string() : record.substr( begin, end - begin );
+}
+
+// Records are matched with the baseline by their scene, configuration and thread count.
+std::string RecordKey( const std::string& record )
+{
+	return FindField( record, "scene" ) + "/" + FindField( record, "config" ) + "/" + FindField( record, "threads" );
+}
+
+bool LoadBaseline( const std::string& path, std::map<std::string, std::string>& baseline )
+{
+	std::ifstream file( path.c_str() );
+	if ( !file )
+		return false;
+	std::string line;
+	while ( std::getline( file, line ) )
+	{
+		if ( !line.empty() && line[0] == '{' )
+			baseline[RecordKey( line )] = line;
+	}
+	return true;
+}
+
+// Compare a record with its baseline record, print every metric that is worse by more than the tolerance,
+// and return the number of regressions.
+size_t CompareWithBaseline( const std::string& record, const std::map<std::string, std::string>& baseline, double tolerance )
+{
+	const std::string key = RecordKey( record );
+	const std::map<std::string, std::string>::const_iterator entry = baseline.find( key );
+	if ( entry == baseline.end() )
+	{
+		std::fprintf( stderr, "note: no baseline for %s\n", key.c_str() );
+		return 0;
+	}
+	size_t regressionCount = 0;
+	for ( const Metric& metric : kMetrics )
+	{
+		const std::string oldField = FindField( entry->second, metric.name );
+		const std::string newField = FindField( record, metric.name );
+		if ( oldField.empty() || newField.empty() )
+			continue;
+		const double oldValue = std::strtod( oldField.c_str(), NULL );
+		const double newValue = std::strtod( newField.c_str(), NULL );
+		if ( oldValue <= 0.0 )
+			continue;
+		const bool regressed = metric.higherIsBetter ? newValue < oldValue * ( 1.0 - tolerance ) : newValue > oldValue * ( 1.0 + tolerance );
+		if ( regressed )
+		{
+			std::fprintf( stderr, "regression: %s %s %g -> %g (%+.1f%%)\n", key.c_str(), metric.name,
+				oldValue, newValue, 100.0 * ( newValue - oldValue ) / oldValue );
+			regressionCount++;
+		}
+	}
+	return regressionCount;
+}
+
+// Create a uniquely-named temporary file with the given suffix, and return its path or an empty string on failure.
+std::string CreateTemporaryFile( const char* suffix )
+{
+	const char* directory = std::getenv( "TMPDIR" );
+	std::string path = std::string( directory ? directory : "/tmp" ) + "/rlra_benchmark_XXXXXX" + suffix;
+	std::vector<char> buffer( path.begin(), path.end() );
+	buffer.push_back( '\0' );
+	const int fd = mkstemps( buffer.data(), (int)std::strlen( suffix ) );
+	if ( fd < 0 )
+		return std::string();
+	close( fd );
+	return std::string( buffer.data() );
+}
+
+void PrintUsage( const char* program )
+{
+	std::fprintf( stderr,
+		"usage: %s [options]\n"
+		"  --scenes LIST       comma-separated scenes (shoebox,multiroom,openfield,highpoly,objfile,plyfile)\n"
+		"  --configs LIST      comma-separated configurations (default,fast)\n"
+		"  --threads LIST      comma-separated thread counts (default: 1,2,4,... up to the hardware thread count)\n"
+		"  --iterations N      number of timed simulations per run (default: 5)\n"
+		"  --rays N            number of rays for the ray query benchmarks (default: 100000)\n"
+		"  --materials PATH    material database JSON file (default: built-in default material)\n"
+		"  --baseline PATH     results of an earlier run to compare with; regressions are reported on stderr\n"
+		"                      and the exit code is 2 if there are any\n"
+		"  --tolerance X       relative change that counts as a regression (default: 0.1)\n",
+		program );
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+	Options options;
+	for ( int i = 1; i < argc; i++ )
+	{
+		const std::string arg = argv[i];
+		if ( arg == "--help" )
+		{
+			PrintUsage( argv[0] );
+			return 0;
+		}
+		if ( i + 1 >= argc )
+		{
+			PrintUsage( argv[0] );
+			return 1;
+		}
+		const std::string value = argv[++i];
+		if ( arg == "--scenes" )
+			options.scenes = Split( value );
+		else if ( arg == "--configs" )
+			options.configs = Split( value );
+		else if ( arg == "--threads" )
+		{
+			for ( const std::string& item : Split( value ) )
+				options.threadCounts.push_back( std::strtoul( item.c_str(), NULL, 10 ) );
+		}
+		else if ( arg == "--iterations" )
+			options.iterations = std::max<size_t>( 1, std::strtoul( value.c_str(), NULL, 10 ) );
+		else if ( arg == "--rays" )
+			options.queryRayCount = std::max<size_t>( 1, std::strtoul( value.c_str(), NULL, 10 ) );
+		else if ( arg == "--materials" )
+			options.materialsPath = value;
+		else if ( arg == "--baseline" )
+			options.baselinePath = value;
+		else if ( arg == "--tolerance" )
+			options.tolerance = std::max( 0.0, std::strtod( value.c_str(), NULL ) );
+		else
+		{
+			PrintUsage( argv[0] );
+			return 1;
+		}
+	}
+
+	if ( options.scenes.empty() )
+	{
+		for ( const SceneType& sceneType : kSceneTypes )
+			options.scenes.push_back( sceneType.name );
+	}
+	if ( options.configs.empty() )
+		options.configs.assign( std::begin( kConfigNames ), std::end( kConfigNames ) );
+	if ( options.threadCounts.empty() )
+	{
+		const size_t hardwareThreads = std::max( 1u, std::thread::hardware_concurrency() );
+		for ( size_t t = 1; t < hardwareThreads; t *= 2 )
+			options.threadCounts.push_back( t );
+		options.threadCounts.push_back( hardwareThreads );
+	}
+
+	// Validate all names before running anything.
+	std::vector<SceneType*> sceneTypes;
+	for ( const std::string& sceneName : options.scenes )
+	{
+		SceneType* sceneType = NULL;
+		for ( SceneType& type : kSceneTypes )
+		{
+			if ( sceneName == type.name )
+				sceneType = &type;
+		}
+		if ( !sceneType )
+		{
+			std::fprintf( stderr, "error: unknown scene '%s'\n", sceneName.c_str() );
+			return 1;
+		}
+		sceneTypes.push_back( sceneType );
+	}
+	for ( const std::string& configName : options.configs )
+	{
+		if ( std::find( std::begin( kConfigNames ), std::end( kConfigNames ), configName ) == std::end( kConfigNames ) )
+		{
+			std::fprintf( stderr, "error: unknown configuration '%s'\n", configName.c_str() );
+			return 1;
+		}
+	}
+
+	std::map<std::string, std::string> baseline;
+	if ( !options.baselinePath.empty() && !LoadBaseline( options.baselinePath, baseline ) )
+	{
+		std::fprintf( stderr, "error: could not read the baseline file '%s'\n", options.baselinePath.c_str() );
+		return 1;
+	}
+
+	// Generate the mesh files for the file loading scenes once, outside of the timed region.
+	int result = 0;
+	for ( SceneType* sceneType : sceneTypes )
+	{
+		if ( !sceneType->meshFilePath || !sceneType->meshFilePath->empty() )
+			continue;
+		*sceneType->meshFilePath = CreateTemporaryFile( sceneType->ply ? ".ply" : ".obj" );
+		if ( !sceneType->meshFilePath->empty() )
+			sceneType->meshFileTriangleCount = WriteMeshFile( *sceneType->meshFilePath, sceneType->ply );
+		if ( sceneType->meshFileTriangleCount == 0 )
+		{
+			std::fprintf( stderr, "error: could not write the mesh file for scene '%s'\n", sceneType->name );
+			result = 1;
+			break;
+		}
+	}
+
+	size_t regressionCount = 0;
+	for ( size_t s = 0; s < sceneTypes.size() && result == 0; s++ )
+	{
+		for ( const std::string& configName : options.configs )
+		{
+			for ( size_t threadCount : options.threadCounts )
+			{
+				std::string record;
+				if ( !RunBenchmarkInChild( options, *sceneTypes[s], configName, std::max<size_t>( 1, threadCount ), record ) )
+				{
+					result = 1;
+					continue;
+				}
+				std::fputs( record.c_str(), stdout );
+				std::fflush( stdout );
+				if ( !options.baselinePath.empty() )
+					regressionCount += CompareWithBaseline( record, baseline, options.tolerance );
+			}
+		}
+	}
+	if ( result == 0 && regressionCount > 0 )
+	{
+		std::fprintf( stderr, "%zu regression(s) compared with %s\n", regressionCount, options.baselinePath.c_str() );
+		result = 2;
+	}
+
+	if ( !gObjFilePath.empty() )
+		std::remove( gObjFilePath.c_str() );
+	if ( !gPlyFilePath.empty() )
+		std::remove( gPlyFilePath.c_str() );
+	return result;
+}